@@ -0,0 +1,8 @@
+TEMPLATE = subdirs
+
+SUBDIRS = \
+    spinstress \
+    fuzz_compile \
+
+spinstress.file = spinstress.pro
+fuzz_compile.file = fuzz_compile.pro
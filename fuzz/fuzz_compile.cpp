@@ -0,0 +1,29 @@
+//
+// fuzz_compile.cpp
+//
+// libFuzzer entry point for the compiler front end. Every input is compiled as
+// a single in-memory object through CompileBuffer(), so Compile1(), Compile2()
+// and the PrintError() reporting all see arbitrary source.
+//
+//   ./openspin_fuzz -close_fd_mask=1 corpus/
+//
+// -close_fd_mask=1 silences the compiler's error output on stdout.
+//
+#include <stdint.h>
+
+#include "openspin.h"
+
+#define MaxFuzzInput        (1024*1024)
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* pData, size_t nSize)
+{
+    if (nSize > MaxFuzzInput)
+    {
+        return 0;
+    }
+
+    CompileBuffer((const char*)pData, (int)nSize, "fuzz.spin", 32768);
+    CleanupMemory(false);
+
+    return 0;
+}
@@ -0,0 +1,18 @@
+TEMPLATE = app
+TARGET = openspin_fuzz
+DESTDIR = ../bin/
+
+CONFIG -= qt debug_and_release app_bundle
+CONFIG += console c++11
+
+# libFuzzer supplies main(), so this target needs clang
+QMAKE_CC = clang
+QMAKE_CXX = clang++
+QMAKE_LINK = clang++
+QMAKE_CXXFLAGS += -g -fsanitize=fuzzer,address,undefined
+QMAKE_LFLAGS += -fsanitize=fuzzer,address,undefined
+
+include(../src/openspin.pri)
+
+SOURCES += \
+    fuzz_compile.cpp \
@@ -0,0 +1,217 @@
+//
+// spinstress.cpp
+//
+// Stress and throughput driver for the compiler front end. Without files it
+// generates synthetic Spin sources (many symbols, long lines, deep nesting,
+// many methods) and compiles each one repeatedly in memory. With files it
+// compiles those instead, which also makes it usable as an AFL target:
+//
+//   afl-fuzz -i seeds -o findings -- ./spinstress @@
+//
+// Results go to stderr, the compiler's own messages go to stdout.
+//
+#include <chrono>
+#include <string>
+
+#include "openspin.h"
+
+#define StressNestDepth     7       // stays under the compiler's block nesting limit of 8
+
+struct StressCase
+{
+    std::string name;
+    std::string source;
+};
+
+static void GenerateManySymbols(std::string& source, int nScale)
+{
+    int nSymbols = nScale * 2000;
+    source += "CON\r\n";
+    for (int i = 0; i < nSymbols; i++)
+    {
+        source += "  C" + std::to_string(i) + " = " + std::to_string(i) + "\r\n";
+    }
+    source += "PUB main : r\r\n";
+    for (int i = 0; i < nSymbols; i++)
+    {
+        source += "  r += C" + std::to_string(i) + "\r\n";
+    }
+}
+
+static void GenerateLongLines(std::string& source, int nScale)
+{
+    int nTerms = nScale * 4000;
+    source += "VAR\r\n  long x\r\nPUB main\r\n  x := 1";
+    for (int i = 0; i < nTerms; i++)
+    {
+        source += " + " + std::to_string(i & 0xFF);
+    }
+    source += "\r\nDAT\r\n  text byte \"";
+    source += std::string(nScale * 16000, 'A');
+    source += "\", 0\r\n";
+}
+
+// nesting past the block limit only exercises the error path, so the scale
+// adds more maximally nested blocks one after another instead of deeper ones
+static void GenerateDeepNesting(std::string& source, int nScale)
+{
+    int nNests = nScale * 16;
+    source += "PUB main | i\r\n";
+    for (int n = 0; n < nNests; n++)
+    {
+        std::string indent = "  ";
+        for (int i = 0; i < StressNestDepth; i++)
+        {
+            source += indent + ((i & 1) ? "if i > " + std::to_string(n + i) : "repeat 2") + "\r\n";
+            indent += "  ";
+        }
+        source += indent + "i := (((((((((i + 1) * 2) - 3) / 4) + 5) * 6) - 7) / 8) + " + std::to_string(n) + ")\r\n";
+    }
+}
+
+static void GenerateManyMethods(std::string& source, int nScale)
+{
+    int nMethods = nScale * 250;
+    source += "PUB main\r\n  m0(0)\r\n";
+    for (int i = 0; i < nMethods; i++)
+    {
+        source += "PRI m" + std::to_string(i) + "(a) : r | b, c\r\n";
+        source += "  b := a + " + std::to_string(i) + "\r\n";
+        if (i + 1 < nMethods)
+        {
+            source += "  r := m" + std::to_string(i + 1) + "(b)\r\n";
+        }
+    }
+}
+
+static bool ReadFileCase(const char* pFilename, StressCase& stressCase)
+{
+    FILE* pFile = fopen(pFilename, "rb");
+    if (!pFile)
+    {
+        fprintf(stderr, "Cannot open %s\n", pFilename);
+        return false;
+    }
+    fseek(pFile, 0, SEEK_END);
+    long nLength = ftell(pFile);
+    fseek(pFile, 0, SEEK_SET);
+    stressCase.name = pFilename;
+    stressCase.source.resize(nLength > 0 ? nLength : 0);
+    if (nLength > 0)
+    {
+        stressCase.source.resize(fread(&stressCase.source[0], 1, nLength, pFile));
+    }
+    fclose(pFile);
+    return true;
+}
+
+static void RunCase(const StressCase& stressCase, int nIterations)
+{
+    double slowest = 0.0;
+    bool bResult = false;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < nIterations; i++)
+    {
+        std::chrono::steady_clock::time_point iterationStart = std::chrono::steady_clock::now();
+        bResult = CompileBuffer(stressCase.source.data(), (int)stressCase.source.size(), "stress.spin", 32768);
+        CleanupMemory(false);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - iterationStart).count();
+        if (elapsed > slowest)
+        {
+            slowest = elapsed;
+        }
+    }
+    double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double megabytes = (double)stressCase.source.size() * nIterations / (1024.0 * 1024.0);
+    fprintf(stderr, "%-24s %10d bytes %6s %10.1f exec/s %8.2f MB/s %8.3f ms slowest\n",
+            stressCase.name.c_str(), (int)stressCase.source.size(), bResult ? "ok" : "error",
+            total > 0.0 ? nIterations / total : 0.0, total > 0.0 ? megabytes / total : 0.0, slowest * 1000.0);
+}
+
+int main(int argc, char* argv[])
+{
+    int nIterations = 10;
+    int nScale = 1;
+    const char* pWriteDir = NULL;
+    int nFirstFile = argc;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            nIterations = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            nScale = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+        {
+            pWriteDir = argv[++i];
+        }
+        else if (argv[i][0] == '-')
+        {
+            fprintf(stderr, "usage: spinstress [-n iterations] [-s scale] [-w seed_dir] [file ...]\n");
+            return 1;
+        }
+        else
+        {
+            nFirstFile = i;
+            break;
+        }
+    }
+    if (nIterations < 1)
+    {
+        nIterations = 1;
+    }
+    if (nScale < 1)
+    {
+        nScale = 1;
+    }
+
+    StressCase cases[4];
+    int nCases = 0;
+    if (nFirstFile < argc)
+    {
+        for (int i = nFirstFile; i < argc; i++)
+        {
+            StressCase fileCase;
+            if (ReadFileCase(argv[i], fileCase))
+            {
+                RunCase(fileCase, nIterations);
+            }
+        }
+        CleanupMemory();
+        return 0;
+    }
+
+    cases[nCases].name = "many_symbols";
+    GenerateManySymbols(cases[nCases++].source, nScale);
+    cases[nCases].name = "long_lines";
+    GenerateLongLines(cases[nCases++].source, nScale);
+    cases[nCases].name = "deep_nesting";
+    GenerateDeepNesting(cases[nCases++].source, nScale);
+    cases[nCases].name = "many_methods";
+    GenerateManyMethods(cases[nCases++].source, nScale);
+
+    for (int i = 0; i < nCases; i++)
+    {
+        if (pWriteDir)
+        {
+            // written out as a seed corpus for the fuzzers
+            std::string path = std::string(pWriteDir) + "/" + cases[i].name + ".spin";
+            FILE* pFile = fopen(path.c_str(), "wb");
+            if (pFile)
+            {
+                fwrite(cases[i].source.data(), 1, cases[i].source.size(), pFile);
+                fclose(pFile);
+            }
+        }
+        RunCase(cases[i], nIterations);
+    }
+
+    CleanupMemory();
+    return 0;
+}
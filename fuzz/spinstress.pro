@@ -0,0 +1,11 @@
+TEMPLATE = app
+TARGET = spinstress
+DESTDIR = ../bin/
+
+CONFIG -= qt debug_and_release app_bundle
+CONFIG += console c++11
+
+include(../src/openspin.pri)
+
+SOURCES += \
+    spinstress.cpp \
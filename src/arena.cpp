@@ -0,0 +1,159 @@
+//
+// arena.cpp
+//
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+struct ArenaBlock
+{
+    ArenaBlock* pNext;      // next older block
+    size_t      nSize;
+    size_t      nUsed;
+};
+
+// keep the block header a multiple of the alignment so the data that follows it is aligned
+#define ArenaHeaderSize     ((sizeof(ArenaBlock) + ArenaAlignment - 1) & ~(size_t)(ArenaAlignment - 1))
+
+Arena s_compileArena = { NULL, NULL };
+Arena s_sourceArena = { NULL, NULL };
+
+// totals across all arenas, the peaks are what a compile reports
+static size_t s_nArenaBytesUsed = 0;
+static size_t s_nArenaBytesReserved = 0;
+static size_t s_nArenaPeakBytesUsed = 0;
+static size_t s_nArenaPeakBytesReserved = 0;
+
+// unlinks the smallest released block that holds nSize bytes, so small requests don't use up the large ones
+static ArenaBlock* TakeFreeBlock(Arena& arena, size_t nSize)
+{
+    ArenaBlock** ppBest = NULL;
+    for (ArenaBlock** ppBlock = &arena.pFree; *ppBlock; ppBlock = &(*ppBlock)->pNext)
+    {
+        if ((*ppBlock)->nSize >= nSize && (ppBest == NULL || (*ppBlock)->nSize < (*ppBest)->nSize))
+        {
+            ppBest = ppBlock;
+        }
+    }
+    if (ppBest == NULL)
+    {
+        return NULL;
+    }
+    ArenaBlock* pBlock = *ppBest;
+    *ppBest = pBlock->pNext;
+    return pBlock;
+}
+
+void* ArenaAlloc(size_t nSize, Arena& arena)
+{
+    nSize = (nSize + ArenaAlignment - 1) & ~(size_t)(ArenaAlignment - 1);
+
+    ArenaBlock* pBlock = arena.pHead;
+    if (pBlock == NULL || pBlock->nSize - pBlock->nUsed < nSize)
+    {
+        pBlock = TakeFreeBlock(arena, nSize);
+        if (pBlock == NULL)
+        {
+            // large requests (list, doc, obj) get a block of their own
+            size_t nBlockSize = nSize > ArenaBlockSize ? nSize : ArenaBlockSize;
+            pBlock = (ArenaBlock*)malloc(ArenaHeaderSize + nBlockSize);
+            if (pBlock == NULL)
+            {
+                printf("Out of memory!\n");
+                exit(-2);
+            }
+            pBlock->nSize = nBlockSize;
+
+            s_nArenaBytesReserved += nBlockSize;
+            if (s_nArenaBytesReserved > s_nArenaPeakBytesReserved)
+            {
+                s_nArenaPeakBytesReserved = s_nArenaBytesReserved;
+            }
+        }
+        pBlock->nUsed = 0;
+        pBlock->pNext = arena.pHead;
+        arena.pHead = pBlock;
+    }
+
+    void* pResult = (char*)pBlock + ArenaHeaderSize + pBlock->nUsed;
+    pBlock->nUsed += nSize;
+
+    s_nArenaBytesUsed += nSize;
+    if (s_nArenaBytesUsed > s_nArenaPeakBytesUsed)
+    {
+        s_nArenaPeakBytesUsed = s_nArenaBytesUsed;
+    }
+
+    return pResult;
+}
+
+void* ArenaAllocZeroed(size_t nSize, Arena& arena)
+{
+    void* pResult = ArenaAlloc(nSize, arena);
+    memset(pResult, 0, nSize);
+    return pResult;
+}
+
+ArenaMark GetArenaMark(Arena& arena)
+{
+    ArenaMark mark;
+    mark.pBlock = arena.pHead;
+    mark.nBlockUsed = arena.pHead ? arena.pHead->nUsed : 0;
+    return mark;
+}
+
+// releases everything allocated from the arena since the mark was taken, the blocks are kept for reuse
+void ArenaRewind(const ArenaMark& mark, Arena& arena)
+{
+    while (arena.pHead != mark.pBlock)
+    {
+        ArenaBlock* pBlock = arena.pHead;
+        arena.pHead = pBlock->pNext;
+        s_nArenaBytesUsed -= pBlock->nUsed;
+        pBlock->nUsed = 0;
+        pBlock->pNext = arena.pFree;
+        arena.pFree = pBlock;
+    }
+    if (arena.pHead)
+    {
+        s_nArenaBytesUsed -= arena.pHead->nUsed - mark.nBlockUsed;
+        arena.pHead->nUsed = mark.nBlockUsed;
+    }
+}
+
+void ArenaReset(Arena& arena)
+{
+    ArenaMark empty = { NULL, 0 };
+    ArenaRewind(empty, arena);
+}
+
+// gives the released blocks back to the system, blocks in use are left alone
+void ArenaTrim(Arena& arena)
+{
+    while (arena.pFree)
+    {
+        ArenaBlock* pNext = arena.pFree->pNext;
+        s_nArenaBytesReserved -= arena.pFree->nSize;
+        free(arena.pFree);
+        arena.pFree = pNext;
+    }
+}
+
+void ArenaResetPeak()
+{
+    s_nArenaPeakBytesUsed = s_nArenaBytesUsed;
+    s_nArenaPeakBytesReserved = s_nArenaBytesReserved;
+}
+
+size_t ArenaPeakBytesUsed()
+{
+    return s_nArenaPeakBytesUsed;
+}
+
+size_t ArenaPeakBytesReserved()
+{
+    return s_nArenaPeakBytesReserved;
+}
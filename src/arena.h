@@ -0,0 +1,50 @@
+//
+// arena.h
+//
+// Compile-scoped bump allocators. Everything a single compile needs is carved
+// out of an arena and released in one step by ArenaReset(). Short-lived
+// buffers can be given back early with GetArenaMark()/ArenaRewind().
+//
+// Released blocks stay with the arena and are reused by later allocations, so
+// repeated compiles don't go back to malloc. ArenaTrim() returns them to the
+// system.
+//
+// s_compileArena holds list, doc, obj, names and tables. s_sourceArena holds
+// the PASCII source, of which only one is live at a time.
+//
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ArenaBlockSize      (256*1024)
+#define ArenaAlignment      16
+
+struct ArenaBlock;
+
+struct Arena
+{
+    ArenaBlock* pHead;      // newest block, blocks are kept in allocation order
+    ArenaBlock* pFree;      // released blocks waiting to be reused
+};
+
+struct ArenaMark
+{
+    ArenaBlock* pBlock;
+    size_t      nBlockUsed;
+};
+
+extern Arena s_compileArena;
+extern Arena s_sourceArena;
+
+void* ArenaAlloc(size_t nSize, Arena& arena = s_compileArena);
+void* ArenaAllocZeroed(size_t nSize, Arena& arena = s_compileArena);
+ArenaMark GetArenaMark(Arena& arena = s_compileArena);
+void ArenaRewind(const ArenaMark& mark, Arena& arena = s_compileArena);
+void ArenaReset(Arena& arena = s_compileArena);
+void ArenaTrim(Arena& arena = s_compileArena);
+void ArenaResetPeak();
+size_t ArenaPeakBytesUsed();
+size_t ArenaPeakBytesReserved();
+
+#endif
@@ -0,0 +1,117 @@
+//
+// imagedelta.cpp
+//
+//
+#include "openspin.h"
+
+static bool PageChanged(const unsigned char* pImage, int nImageSize, const unsigned char* pPrevious, int nPreviousSize, int nPage)
+{
+    int nStart = nPage * DeltaPageSize;
+    int nLength = nImageSize - nStart < DeltaPageSize ? nImageSize - nStart : DeltaPageSize;
+
+    // nothing is known about bytes past the end of the previous image, so those pages are always sent
+    if (nStart + nLength > nPreviousSize)
+    {
+        return true;
+    }
+    return memcmp(&pImage[nStart], &pPrevious[nStart], nLength) != 0;
+}
+
+bool WriteImageDelta(const char* pPreviousFile, const unsigned char* pImage, int nImageSize,
+                     const char* pDeltaFile, const char* pManifestFile, bool bQuiet)
+{
+    unsigned char* pPrevious = NULL;
+    int nPreviousSize = 0;
+
+    FILE* pFile = fopen(pPreviousFile, "rb");
+    if (!pFile)
+    {
+        printf("Cannot open previous image: %s\n", pPreviousFile);
+        return false;
+    }
+    fseek(pFile, 0, SEEK_END);
+    nPreviousSize = (int)ftell(pFile);
+    if (nPreviousSize > 0)
+    {
+        pPrevious = (unsigned char*)ArenaAlloc(nPreviousSize);
+        fseek(pFile, 0, SEEK_SET);
+        nPreviousSize = (int)fread(pPrevious, 1, nPreviousSize, pFile);
+    }
+    fclose(pFile);
+
+    if (nPreviousSize != nImageSize && !bQuiet)
+    {
+        printf("Previous image is %d bytes, new image is %d bytes\n", nPreviousSize, nImageSize);
+    }
+
+    FILE* pDelta = fopen(pDeltaFile, "wb");
+    if (!pDelta)
+    {
+        printf("Cannot open delta file: %s\n", pDeltaFile);
+        return false;
+    }
+    FILE* pManifest = fopen(pManifestFile, "w");
+    if (!pManifest)
+    {
+        printf("Cannot open manifest file: %s\n", pManifestFile);
+        fclose(pDelta);
+        return false;
+    }
+
+    int nPages = (nImageSize + DeltaPageSize - 1) / DeltaPageSize;
+
+    // count the ranges first so the header can be written in one go
+    int nRanges = 0;
+    for (int nPage = 0; nPage < nPages; nPage++)
+    {
+        if (PageChanged(pImage, nImageSize, pPrevious, nPreviousSize, nPage) &&
+            (nPage == 0 || !PageChanged(pImage, nImageSize, pPrevious, nPreviousSize, nPage - 1)))
+        {
+            nRanges++;
+        }
+    }
+
+    fwrite("OSDL", 1, 4, pDelta);
+    WriteLong(pDelta, ImageDeltaVersion);
+    WriteLong(pDelta, DeltaPageSize);
+    WriteLong(pDelta, nImageSize);
+    WriteLong(pDelta, nRanges);
+
+    fprintf(pManifest, "image %d\npage_size %d\n", nImageSize, DeltaPageSize);
+
+    int nChangedPages = 0;
+    int nPage = 0;
+    while (nPage < nPages)
+    {
+        if (!PageChanged(pImage, nImageSize, pPrevious, nPreviousSize, nPage))
+        {
+            nPage++;
+            continue;
+        }
+
+        int nFirstPage = nPage;
+        while (nPage < nPages && PageChanged(pImage, nImageSize, pPrevious, nPreviousSize, nPage))
+        {
+            nPage++;
+        }
+        nChangedPages += nPage - nFirstPage;
+
+        int nOffset = nFirstPage * DeltaPageSize;
+        int nEnd = nPage * DeltaPageSize < nImageSize ? nPage * DeltaPageSize : nImageSize;
+        WriteLong(pDelta, nOffset);
+        WriteLong(pDelta, nEnd - nOffset);
+        fwrite(&pImage[nOffset], 1, nEnd - nOffset, pDelta);
+
+        fprintf(pManifest, "range 0x%06X %d\n", nOffset, nEnd - nOffset);
+    }
+
+    fclose(pManifest);
+    fclose(pDelta);
+
+    if (!bQuiet)
+    {
+        printf("Delta is %d of %d pages in %d ranges\n", nChangedPages, nPages, nRanges);
+    }
+
+    return true;
+}
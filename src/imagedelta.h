@@ -0,0 +1,25 @@
+//
+// imagedelta.h
+//
+// Compares a freshly composed EEPROM image against the previous one and writes
+// the changed pages, merged into contiguous ranges, plus a text manifest. Only
+// the full eeprom_size image is diffed, so zeroed VAR space and the stack
+// markers are covered and the boot ROM checksum over hub RAM stays valid.
+// Delta file fields are little endian 32-bit values:
+//
+//   header   magic 'OSDL', version, page size, image size, range count
+//   ranges   offset, length, followed by length bytes of new image data
+//
+// Applying every range to the previous image gives the new image byte for byte,
+// including the checksum byte in the first page.
+//
+#ifndef IMAGEDELTA_H
+#define IMAGEDELTA_H
+
+#define ImageDeltaVersion   1
+#define DeltaPageSize       64
+
+bool WriteImageDelta(const char* pPreviousFile, const unsigned char* pImage, int nImageSize,
+                     const char* pDeltaFile, const char* pManifestFile, bool bQuiet);
+
+#endif
@@ -60,6 +60,10 @@ int main(int argc, char* argv[])
     bool bFileTreeOutputOnly = false;
     bool bFileListOutputOnly = false;
     bool bDumpSymbols = false;
+    bool bObjectReport = false;
+    bool bSymbolMap = false;
+    char* reportfile = NULL;
+    char* previousfile = NULL;
     s_bUnusedMethodElimination = false;
 
     bool s_bFinalCompile = false;
@@ -82,10 +86,16 @@ int main(int argc, char* argv[])
     QCommandLineOption includeDirectory(    QStringList() << "I" << "L",            QObject::tr("Add a directory to the include path"),             QObject::tr("DIR"));
     QCommandLineOption outputFile(          QStringList() << "o" << "output",       QObject::tr("Output filename"),                                 QObject::tr("FILE"));
     QCommandLineOption EEPROMSize(          QStringList() << "M" << "eeprom-size",  QObject::tr("Set EEPROM maximum size (up to 16777216 bytes)"),  QObject::tr("SIZE"));
+    QCommandLineOption reportJSON(          QStringList() << "report-json",         QObject::tr("Write per-object size report as JSON"),            QObject::tr("FILE"));
+    QCommandLineOption previousImage(       QStringList() << "delta",               QObject::tr("Write changed pages against a previous EEPROM image (with -e)"),    QObject::tr("FILE"));
+    QCommandLineOption traceFile(           QStringList() << "trace",               QObject::tr("Write build timeline in Chrome trace format"),     QObject::tr("FILE"));
 
     parser.addOption(includeDirectory);
     parser.addOption(outputFile);
     parser.addOption(EEPROMSize);
+    parser.addOption(reportJSON);
+    parser.addOption(previousImage);
+    parser.addOption(traceFile);
 
     QCommandLineOption outputBinary(        QStringList() << "b" << "binary",       QObject::tr("Output in binary format"));
     QCommandLineOption outputEEPROM(        QStringList() << "e" << "eeprom",       QObject::tr("Output in EEPROM format"));
@@ -96,6 +106,8 @@ int main(int argc, char* argv[])
     QCommandLineOption verboseMode(         QStringList() << "v" << "verbose",      QObject::tr("Verbose output"));
     QCommandLineOption symbolInformation(   QStringList() << "s" << "symbol",       QObject::tr("Dump PUB & CON symbol information for top object"));
     QCommandLineOption unusedMethodRemoval( QStringList() << "u" << "unused",       QObject::tr("Enable unused method removal (EXPERIMENTAL!)"));
+    QCommandLineOption objectReport(        QStringList() << "r" << "report",       QObject::tr("Print per-object size report"));
+    QCommandLineOption symbolMap(           QStringList() << "m" << "map",          QObject::tr("Write symbol and line map next to the output file (not with -u)"));
 
     parser.addOption(outputBinary);
     parser.addOption(outputEEPROM);
@@ -106,6 +118,8 @@ int main(int argc, char* argv[])
     parser.addOption(verboseMode);
     parser.addOption(symbolInformation);
     parser.addOption(unusedMethodRemoval);
+    parser.addOption(objectReport);
+    parser.addOption(symbolMap);
 
     parser.addPositionalArgument("object",  QObject::tr("Spin file to compile"), "OBJECT");
 
@@ -121,11 +135,40 @@ int main(int argc, char* argv[])
     if (parser.isSet(verboseMode))          bVerbose = true;
     if (parser.isSet(symbolInformation))    bDumpSymbols = true;
     if (parser.isSet(unusedMethodRemoval))  s_bUnusedMethodElimination = true;
+    if (parser.isSet(objectReport))         bObjectReport = true;
+    if (parser.isSet(symbolMap))            bSymbolMap = true;
+
+    // the names have to be saved while each object is compiled
+    s_bRecordSymbols = bSymbolMap;
+
+    // -u removes eliminated methods from the method table, so the map can no longer
+    // tell which source method a slot belongs to
+    if (bSymbolMap && s_bUnusedMethodElimination)
+    {
+        QTextStream(stderr) << "ERROR: -m cannot be combined with -u." << endl;
+        return 1;
+    }
 
     QByteArray ba = parser.value(outputFile).toLocal8Bit();
     if (!parser.value(outputFile).isEmpty())
         outfile = ba.data();
 
+    QByteArray reportba = parser.value(reportJSON).toLocal8Bit();
+    if (!parser.value(reportJSON).isEmpty())
+        reportfile = reportba.data();
+
+    QByteArray previousba = parser.value(previousImage).toLocal8Bit();
+    if (!parser.value(previousImage).isEmpty())
+        previousfile = previousba.data();
+
+    // a .binary stops at the VAR area, so a delta of it would leave stale bytes in an
+    // EEPROM past the new image and break the checksum the boot ROM takes over hub RAM
+    if (previousfile && bBinary)
+    {
+        QTextStream(stderr) << "ERROR: --delta needs -e, deltas are taken against the full EEPROM image." << endl;
+        return 1;
+    }
+
     if (!parser.value(EEPROMSize).isEmpty())
     {
         eeprom_size = parser.value(EEPROMSize).toInt();
@@ -163,6 +206,9 @@ int main(int argc, char* argv[])
     if (bFileTreeOutputOnly || bFileListOutputOnly || bDumpSymbols)
     {
         bQuiet = true;
+
+        // no image is written in these modes, so FILE payloads only need their sizes
+        s_bDataSizeOnly = true;
     }
 
     // replace .spin with .binary
@@ -177,6 +223,10 @@ int main(int argc, char* argv[])
         return 1;
     }
 
+    // the arguments are valid from here on, so every exit goes through CleanupMemory() and writes the trace
+    if (!parser.value(traceFile).isEmpty())
+        StartTrace(parser.value(traceFile).toLocal8Bit().data());
+
     // output file name
 
     QString outputfile = fi.canonicalPath() + "/" + fi.completeBaseName() + ".";
@@ -210,15 +260,13 @@ restart_compile:
     s_pCompilerData->bUnusedMethodElimination = s_bUnusedMethodElimination;
     s_pCompilerData->bFinalCompile = s_bFinalCompile;
 
-    s_pCompilerData->list = new char[ListLimit];
+    s_pCompilerData->list = (char*)ArenaAllocZeroed(ListLimit);
     s_pCompilerData->list_limit = ListLimit;
-    memset(s_pCompilerData->list, 0, ListLimit);
 
     if (bDocMode && !bQuiet)
     {
-        s_pCompilerData->doc = new char[DocLimit];
+        s_pCompilerData->doc = (char*)ArenaAllocZeroed(DocLimit);
         s_pCompilerData->doc_limit = DocLimit;
-        memset(s_pCompilerData->doc, 0, DocLimit);
     }
     else
     {
@@ -230,7 +278,7 @@ restart_compile:
 
     // allocate space for obj based on eeprom size command line option
     s_pCompilerData->obj_limit = eeprom_size > min_obj_limit ? eeprom_size : min_obj_limit;
-    s_pCompilerData->obj = new unsigned char[s_pCompilerData->obj_limit];
+    s_pCompilerData->obj = (unsigned char*)ArenaAlloc(s_pCompilerData->obj_limit);
 
     // copy filename into obj_title, and chop off the .spin
     strcpy(s_pCompilerData->obj_title, spin.file());
@@ -258,14 +306,44 @@ restart_compile:
         }
         unsigned char* pBuffer = NULL;
         int bufferSize = 0;
-        if (ComposeRAM(&pBuffer, bufferSize, bBinary, eeprom_size))
+        TraceBegin("compose", "output");
+        bool bComposed = ComposeRAM(&pBuffer, bufferSize, bBinary, eeprom_size);
+        TraceEnd();
+        if (bComposed)
         {
+            // done before the image is written, the previous image may be the output file itself
+            if (previousfile)
+            {
+                QFileInfo ofi(outputfile);
+                QString deltafile = ofi.path() + "/" + ofi.completeBaseName() + ".delta";
+                QString manifestfile = ofi.path() + "/" + ofi.completeBaseName() + ".manifest";
+                if (!WriteImageDelta(previousfile, pBuffer, bufferSize,
+                                     deltafile.toLocal8Bit().data(), manifestfile.toLocal8Bit().data(), bQuiet))
+                {
+                    CleanupMemory();
+                    return 1;
+                }
+            }
+
+            TraceBegin("write", "output");
             FILE* pFile = fopen(outputfile.toLocal8Bit().data(), "wb");
             if (pFile)
             {
                 fwrite(pBuffer, bufferSize, 1, pFile);
                 fclose(pFile);
             }
+            TraceEnd();
+
+            if (bSymbolMap)
+            {
+                QFileInfo ofi(outputfile);
+                QString mapfile = ofi.path() + "/" + ofi.completeBaseName() + ".map";
+                if (!WriteSymbolMap(mapfile.toLocal8Bit().data()))
+                {
+                    CleanupMemory();
+                    return 1;
+                }
+            }
         }
         else
         {
@@ -276,9 +354,11 @@ restart_compile:
         if (!bQuiet)
         {
            printf("Program size is %d bytes\n", bufferSize);
+           if (bVerbose)
+           {
+              printf("Peak compile memory is %d bytes (%d reserved)\n", (int)ArenaPeakBytesUsed(), (int)ArenaPeakBytesReserved());
+           }
         }
-
-        delete [] pBuffer;
     }
 
     if (bDumpSymbols)
@@ -337,6 +417,20 @@ restart_compile:
         }
     }
 
+    if (bObjectReport)
+    {
+        PrintObjectReport(eeprom_size);
+    }
+
+    if (reportfile)
+    {
+        if (!WriteObjectReportJSON(reportfile, eeprom_size))
+        {
+            CleanupMemory();
+            return 1;
+        }
+    }
+
     if (bFileListOutputOnly)
     {
         for (int i = 0; i < s_nFilesAccessed; i++)
@@ -407,7 +501,5 @@ restart_compile:
         }
     }
 
-    CleanupMemory();
-
-    return 0;
+    return CleanupMemory() ? 0 : 1;
 }
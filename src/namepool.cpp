@@ -0,0 +1,63 @@
+//
+// namepool.cpp
+//
+//
+#include "openspin.h"
+
+static PooledName* s_namePool[NamePoolBuckets];
+
+static bool HasSpinExtension(const char* pName, int nLength)
+{
+    return nLength >= 5 && memcmp(&pName[nLength - 5], ".spin", 5) == 0;
+}
+
+// interns pName followed by pSuffix without building the joined name first
+static PooledName* InternParts(const char* pName, int nLength, const char* pSuffix, int nSuffixLength)
+{
+    unsigned int hash = HashBytes(HashBytes(HashSeed, pName, nLength), pSuffix, nSuffixLength);
+
+    int nTotalLength = nLength + nSuffixLength;
+    PooledName** ppBucket = &s_namePool[hash & (NamePoolBuckets - 1)];
+    for (PooledName* pEntry = *ppBucket; pEntry; pEntry = pEntry->pNext)
+    {
+        if (pEntry->hash == hash && pEntry->length == nTotalLength &&
+            memcmp(pEntry->text, pName, nLength) == 0 && memcmp(&pEntry->text[nLength], pSuffix, nSuffixLength) == 0)
+        {
+            return pEntry;
+        }
+    }
+
+    PooledName* pEntry = (PooledName*)ArenaAlloc(sizeof(PooledName) + nTotalLength);
+    pEntry->hash = hash;
+    pEntry->length = nTotalLength;
+    memcpy(pEntry->text, pName, nLength);
+    memcpy(&pEntry->text[nLength], pSuffix, nSuffixLength);
+    pEntry->text[nTotalLength] = 0;
+    pEntry->baseLength = HasSpinExtension(pEntry->text, nTotalLength) ? nTotalLength - 5 : nTotalLength;
+    pEntry->pNext = *ppBucket;
+    *ppBucket = pEntry;
+
+    return pEntry;
+}
+
+PooledName* InternName(const char* pName, int nLength)
+{
+    return InternParts(pName, nLength, "", 0);
+}
+
+// object references may leave off the .spin extension, this adds it when missing
+PooledName* InternSpinFilename(const char* pName)
+{
+    int nLength = (int)strlen(pName);
+    if (HasSpinExtension(pName, nLength))
+    {
+        return InternParts(pName, nLength, "", 0);
+    }
+    return InternParts(pName, nLength, ".spin", 5);
+}
+
+// the names live in the arena, so this has to go along with ArenaReset()
+void ResetNamePool()
+{
+    memset(s_namePool, 0, sizeof(s_namePool));
+}
@@ -0,0 +1,26 @@
+//
+// namepool.h
+//
+// Interned, length-tracked object names. Each distinct name is stored once in
+// the compile arena and shared by every reference to it, so the recursion
+// passes pointers around instead of copying names into fixed-size buffers.
+//
+#ifndef NAMEPOOL_H
+#define NAMEPOOL_H
+
+#define NamePoolBuckets     1024    // power of two
+
+struct PooledName
+{
+    PooledName*  pNext;
+    unsigned int hash;
+    int          length;
+    int          baseLength;    // length without the .spin extension
+    char         text[1];
+};
+
+PooledName* InternName(const char* pName, int nLength);
+PooledName* InternSpinFilename(const char* pName);
+void ResetNamePool();
+
+#endif
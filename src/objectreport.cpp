@@ -0,0 +1,137 @@
+//
+// objectreport.cpp
+//
+//
+#include "openspin.h"
+
+static ObjectReportEntry s_objectReport[MAX_FILES];
+static bool s_bObjectInHeap[MAX_FILES];
+static int s_nObjectReportCount = 0;
+static int s_nHeapObjects = 0;
+static int s_nHeapBytes = 0;
+
+void ResetObjectReport()
+{
+    s_nObjectReportCount = 0;
+    s_nHeapObjects = 0;
+    s_nHeapBytes = 0;
+}
+
+// entries are reserved when an object is entered so the report comes out in tree order
+int BeginObjectReport(const char* pFilename, int nDepth)
+{
+    if (s_nObjectReportCount >= MAX_FILES)
+    {
+        return -1;
+    }
+
+    ObjectReportEntry& entry = s_objectReport[s_nObjectReportCount];
+    memset(&entry, 0, sizeof(ObjectReportEntry));
+    strncpy(entry.filename, pFilename, sizeof(entry.filename) - 1);
+    entry.depth = nDepth;
+    s_bObjectInHeap[s_nObjectReportCount] = false;
+
+    return s_nObjectReportCount++;
+}
+
+void FinishObjectReport(int nIndex, CompilerData* pCompilerData)
+{
+    if (nIndex < 0)
+    {
+        return;
+    }
+
+    ObjectReportEntry& entry = s_objectReport[nIndex];
+    entry.psize = pCompilerData->psize;
+    entry.vsize = pCompilerData->vsize;
+    entry.stack_requirement = pCompilerData->stack_requirement;
+
+    // info_dat entries carry the obj range of each DAT block in data0/data1
+    for (int i = 0; i < pCompilerData->info_count; i++)
+    {
+        if (pCompilerData->info_type[i] == info_dat)
+        {
+            entry.dat_bytes += pCompilerData->info_data1[i] - pCompilerData->info_data0[i];
+        }
+    }
+
+    for (int i = 0; i < pCompilerData->dat_files; i++)
+    {
+        entry.file_bytes += pCompilerData->dat_lengths[i];
+    }
+
+    // AddObjectToHeap() only keeps the first copy of an object with a given name
+    bool bAlreadyInHeap = false;
+    for (int i = 0; i < s_nObjectReportCount; i++)
+    {
+        if (s_bObjectInHeap[i] && strcmp(s_objectReport[i].filename, entry.filename) == 0)
+        {
+            bAlreadyInHeap = true;
+            break;
+        }
+    }
+    if (!bAlreadyInHeap)
+    {
+        s_bObjectInHeap[nIndex] = true;
+        s_nHeapObjects++;
+        s_nHeapBytes += entry.psize;
+    }
+    entry.heap_objects = s_nHeapObjects;
+    entry.heap_bytes = s_nHeapBytes;
+}
+
+static int RuntimeSize(const ObjectReportEntry& entry)
+{
+    // same figure CompileRecursively() checks against the eeprom size
+    return 0x10 + entry.psize + entry.vsize + (entry.stack_requirement << 2);
+}
+
+void PrintObjectReport(unsigned int eeprom_size)
+{
+    if (s_nObjectReportCount == 0)
+    {
+        return;
+    }
+
+    printf("%-40s %7s %7s %7s %7s %7s %7s\n", "Object", "psize", "vsize", "stack", "DAT", "FILE", "heap");
+    for (int i = 0; i < s_nObjectReportCount; i++)
+    {
+        const ObjectReportEntry& entry = s_objectReport[i];
+
+        char name[41];
+        snprintf(name, sizeof(name), "%*s%s", entry.depth << 1, "", entry.filename);
+        printf("%-40s %7d %7d %7d %7d %7d %7d\n", name, entry.psize, entry.vsize, entry.stack_requirement << 2,
+               entry.dat_bytes, entry.file_bytes, entry.heap_bytes);
+    }
+
+    const ObjectReportEntry& top = s_objectReport[0];
+    printf("Runtime memory is %d of %d bytes (%d free)\n", RuntimeSize(top), eeprom_size, (int)eeprom_size - RuntimeSize(top));
+    printf("Object heap holds %d objects, %d bytes\n", s_nHeapObjects, s_nHeapBytes);
+}
+
+bool WriteObjectReportJSON(const char* pFilename, unsigned int eeprom_size)
+{
+    FILE* pFile = fopen(pFilename, "w");
+    if (!pFile)
+    {
+        printf("Cannot open report file: %s\n", pFilename);
+        return false;
+    }
+
+    int nRuntimeSize = s_nObjectReportCount > 0 ? RuntimeSize(s_objectReport[0]) : 0;
+    fprintf(pFile, "{\n  \"eeprom_size\": %u,\n  \"runtime_size\": %d,\n  \"heap_objects\": %d,\n  \"heap_bytes\": %d,\n  \"objects\": [",
+            eeprom_size, nRuntimeSize, s_nHeapObjects, s_nHeapBytes);
+    for (int i = 0; i < s_nObjectReportCount; i++)
+    {
+        const ObjectReportEntry& entry = s_objectReport[i];
+        fprintf(pFile, "%s\n    { \"file\": ", i > 0 ? "," : "");
+        WriteJSONString(pFile, entry.filename);
+        fprintf(pFile, ", \"depth\": %d, \"psize\": %d, \"vsize\": %d, \"stack_bytes\": %d, \"dat_bytes\": %d, \"file_bytes\": %d, \"heap_objects\": %d, \"heap_bytes\": %d }",
+                entry.depth, entry.psize, entry.vsize, entry.stack_requirement << 2, entry.dat_bytes, entry.file_bytes,
+                entry.heap_objects, entry.heap_bytes);
+    }
+    fprintf(pFile, "\n  ]\n}\n");
+    fclose(pFile);
+
+    return true;
+}
@@ -0,0 +1,31 @@
+//
+// objectreport.h
+//
+// Per-object size/budget figures gathered while CompileRecursively()
+// walks the object tree, printed as text or written out as JSON.
+//
+#ifndef OBJECTREPORT_H
+#define OBJECTREPORT_H
+
+#include "PropellerCompiler.h"
+
+struct ObjectReportEntry
+{
+    char filename[256];
+    int  depth;
+    int  psize;
+    int  vsize;
+    int  stack_requirement; // in longs
+    int  dat_bytes;         // bytes emitted by DAT blocks (FILE payloads included)
+    int  file_bytes;        // bytes pulled in by FILE directives
+    int  heap_objects;      // distinct objects in the heap once this one was added
+    int  heap_bytes;        // psize total of those heap entries
+};
+
+void ResetObjectReport();
+int BeginObjectReport(const char* pFilename, int nDepth);
+void FinishObjectReport(int nIndex, CompilerData* pCompilerData);
+void PrintObjectReport(unsigned int eeprom_size);
+bool WriteObjectReportJSON(const char* pFilename, unsigned int eeprom_size);
+
+#endif
@@ -19,6 +19,8 @@ int  s_nObjStackPtr = 0;
 int  s_nFilesAccessed = 0;
 char s_filesAccessed[MAX_FILES][PATH_MAX];
 bool s_bUnusedMethodElimination = true;
+bool s_bDataSizeOnly = false;
+bool s_bRecordSymbols = false;
 
 FILE* OpenFileInPath(const char *name, const char *mode)
 {
@@ -80,6 +82,7 @@ char* LoadFile(char* pFilename, int* pnLength)
 {
     char* pBuffer = 0;
 
+    TraceBegin("load", "io");
     FILE* pFile = OpenFileInPath(pFilename, "rb");
     if (pFile != NULL)
     {
@@ -89,7 +92,7 @@ char* LoadFile(char* pFilename, int* pnLength)
 
         if (*pnLength > 0)
         {
-            pBuffer = (char*)malloc(*pnLength+1); // allocate a buffer that is the size of the file plus one char
+            pBuffer = (char*)ArenaAlloc(*pnLength+1); // allocate a buffer that is the size of the file plus one char
             pBuffer[*pnLength] = 0; // set the end of the buffer to 0 (null)
 
             // seek back to the beginning of the file and read it in
@@ -98,6 +101,7 @@ char* LoadFile(char* pFilename, int* pnLength)
         }
         fclose(pFile);
     }
+    TraceEnd();
 
     return pBuffer;
 }
@@ -124,39 +128,140 @@ int GetData(unsigned char* pDest, char* pFileName, int nMaxSize)
     return nBytesRead;
 }
 
-bool GetPASCIISource(char* pFilename)
+// returns the number of bytes GetData() would read without reading them, or -1 if it can't be opened
+int GetDataSize(char* pFileName, int nMaxSize)
 {
-    // read in file to temp buffer, convert to PASCII, and assign to s_pCompilerData->source
-    int nLength = 0;
-    char* pBuffer = LoadFile(pFilename, &nLength);
-    if (pBuffer)
+    FILE* pFile = OpenFileInPath(pFileName, "rb");
+    if (!pFile)
+    {
+        printf("Cannot find/open dat file: %s \n", pFileName);
+        return -1;
+    }
+
+    fseek(pFile, 0, SEEK_END);
+    int nSize = (int)ftell(pFile);
+    fclose(pFile);
+
+    // GetData() stops at nMaxSize, so the size has to as well or the two paths would disagree
+    return nSize < nMaxSize ? nSize : nMaxSize;
+}
+
+// FNV-1a, continued from hash so data can be hashed in pieces, start with HashSeed
+unsigned int HashBytes(unsigned int hash, const void* pData, int nLength)
+{
+    const unsigned char* pBytes = (const unsigned char*)pData;
+    for (int i = 0; i < nLength; i++)
+    {
+        hash ^= pBytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// writes value as 4 little endian bytes, used by the symbol map and image delta formats
+void WriteLong(FILE* pFile, unsigned int value)
+{
+    unsigned char bytes[4];
+    bytes[0] = (unsigned char)value;
+    bytes[1] = (unsigned char)(value >> 8);
+    bytes[2] = (unsigned char)(value >> 16);
+    bytes[3] = (unsigned char)(value >> 24);
+    fwrite(bytes, 1, 4, pFile);
+}
+
+// writes pString as a quoted JSON string, used by the JSON report and the trace
+void WriteJSONString(FILE* pFile, const char* pString)
+{
+    fputc('"', pFile);
+    for (const char* p = pString; *p; p++)
     {
-        char* pPASCIIBuffer = new char[nLength+1];
-        if (!UnicodeToPASCII(pBuffer, nLength, pPASCIIBuffer, false))
+        if (*p == '"' || *p == '\\')
         {
-            printf("Unrecognized text encoding format!\n");
-            delete [] pPASCIIBuffer;
-            free(pBuffer);
-            return false;
+            fputc('\\', pFile);
+            fputc(*p, pFile);
         }
-
-        // clean up any previous buffer
-        if (s_pCompilerData->source)
+        else if ((unsigned char)*p < 0x20)
         {
-            delete [] s_pCompilerData->source;
+            fprintf(pFile, "\\u%04x", (unsigned char)*p);
         }
+        else
+        {
+            fputc(*p, pFile);
+        }
+    }
+    fputc('"', pFile);
+}
 
-        s_pCompilerData->source = pPASCIIBuffer;
-
-        free(pBuffer);
+// converts pBuffer to PASCII and makes it s_pCompilerData->source, replacing the previous source
+static bool SetPASCIISource(char* pBuffer, int nLength)
+{
+    // only one source is live at a time, so the previous one is released first
+    s_pCompilerData->source = NULL;
+    ArenaReset(s_sourceArena);
+
+    char* pPASCIIBuffer = (char*)ArenaAlloc(nLength+1, s_sourceArena);
+    TraceBegin("PASCII conversion", "io");
+    bool bConverted = UnicodeToPASCII(pBuffer, nLength, pPASCIIBuffer, false);
+    TraceEnd();
+    if (!bConverted)
+    {
+        printf("Unrecognized text encoding format!\n");
+        return false;
     }
-    else
+
+    s_pCompilerData->source = pPASCIIBuffer;
+    return true;
+}
+
+bool GetPASCIISource(char* pFilename)
+{
+    // read in file to temp buffer, convert to PASCII, and assign to s_pCompilerData->source
+    ArenaMark mark = GetArenaMark();
+    int nLength = 0;
+    char* pBuffer = LoadFile(pFilename, &nLength);
+    if (!pBuffer)
     {
         s_pCompilerData->source = NULL;
+        ArenaReset(s_sourceArena);
         return false;
     }
 
-    return true;
+    // the temp buffer is the last thing allocated, so it can be given back right away
+    bool bResult = SetPASCIISource(pBuffer, nLength);
+    ArenaRewind(mark);
+
+    return bResult;
+}
+
+// copies source[nStart..nEnd) into pDest, clipped to the buffer and to the nSourceLength bytes of source
+static void CopyErrorText(char* pDest, int nDestSize, int nStart, int nEnd, int nSourceLength)
+{
+    if (nStart < 0)
+    {
+        nStart = 0;
+    }
+    if (nStart > nSourceLength)
+    {
+        nStart = nSourceLength;
+    }
+    if (nEnd > nSourceLength)
+    {
+        nEnd = nSourceLength;
+    }
+    int nLength = nEnd - nStart;
+    if (nLength < 0)
+    {
+        nLength = 0;
+    }
+    if (nLength > nDestSize - 1)
+    {
+        nLength = nDestSize - 1;
+    }
+    if (nLength > 0)
+    {
+        memcpy(pDest, &s_pCompilerData->source[nStart], nLength);
+    }
+    pDest[nLength] = 0;
 }
 
 void PrintError(const char* pFilename, const char* pErrorString)
@@ -171,28 +276,48 @@ void PrintError(const char* pFilename, const char* pErrorString)
 
     printf("%s(%d:%d) : error : %s\n", pFilename, lineNumber, column, pErrorString);
 
+    // the offsets come from the compiler's scan position, which can sit past the end of the source
+    int nSourceLength = s_pCompilerData->source ? (int)strlen(s_pCompilerData->source) : 0;
+
     char errorItem[512];
     char errorLine[512];
-    if ( offendingItemStart == offendingItemEnd && s_pCompilerData->source[offendingItemStart] == 0 )
+    if ( offendingItemStart == offendingItemEnd && (offendingItemStart < 0 || offendingItemStart >= nSourceLength) )
     {
         strcpy(errorLine, "End Of File");
         strcpy(errorItem, "N/A");
     }
     else
     {
-        strncpy(errorLine, &s_pCompilerData->source[offsetToStartOfLine], offsetToEndOfLine - offsetToStartOfLine);
-        errorLine[offsetToEndOfLine - offsetToStartOfLine] = 0;
-
-        strncpy(errorItem, &s_pCompilerData->source[offendingItemStart], offendingItemEnd - offendingItemStart);
-        errorItem[offendingItemEnd - offendingItemStart] = 0;
+        CopyErrorText(errorLine, sizeof(errorLine), offsetToStartOfLine, offsetToEndOfLine, nSourceLength);
+        CopyErrorText(errorItem, sizeof(errorItem), offendingItemStart, offendingItemEnd, nSourceLength);
     }
 
     printf("Line:\n%s\nOffending Item: %s\n", errorLine, errorItem);
 }
 
+// current_filename is what the compiler reports in errors, the object name without .spin
+static void SetCurrentFilename(const PooledName* pName)
+{
+    memcpy(s_pCompilerData->current_filename, pName->text, pName->baseLength);
+    s_pCompilerData->current_filename[pName->baseLength] = 0;
+}
+
 bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly, int& nCompileIndex)
 {
     nCompileIndex++;
+    PooledName* pName = InternName(pFilename, (int)strlen(pFilename));
+    pFilename = pName->text;
+
+    // the compiler and the object heap still keep names in 256 byte slots
+    if (pName->length >= 256)
+    {
+        printf("%s : error : Object filename exceeds %d characters.\n", pFilename, 255);
+        return false;
+    }
+
+    // left open on errors, FinishTrace() closes whatever is still open
+    TraceBegin(pFilename, "object");
+    int nReportIndex = BeginObjectReport(pFilename, s_nObjStackPtr);
     if (s_nObjStackPtr > 0 && (!bQuiet || bFileTreeOutputOnly))
     {
         char spaces[] = "                              \0";
@@ -216,15 +341,12 @@ bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly,
         AddObjectName(pFilename, nCompileIndex);
     }
 
-    strcpy(s_pCompilerData->current_filename, pFilename);
-    char* pExtension = strstr(s_pCompilerData->current_filename, ".spin");
-    if (pExtension != 0)
-    {
-        *pExtension = 0;
-    }
+    SetCurrentFilename(pName);
 
     // first pass on object
+    TraceBegin("pass 1", "compile");
     const char* pErrorString = Compile1();
+    TraceEnd();
     if (pErrorString != 0)
     {
         PrintError(pFilename, pErrorString);
@@ -233,26 +355,24 @@ bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly,
 
     if (s_pCompilerData->obj_files > 0)
     {
-        char filenames[file_limit*256];
-
+        // the obj filenames with .spin appended if they don't have it, obj_filenames is
+        // overwritten by the children's passes so the names are kept in the pool
         int numObjects = s_pCompilerData->obj_files;
+        PooledName** ppObjNames = (PooledName**)ArenaAlloc(numObjects * sizeof(PooledName*));
         for (int i = 0; i < numObjects; i++)
         {
-            // copy the obj filename appending .spin if it doesn't have it.
-            strcpy(&filenames[i<<8], &(s_pCompilerData->obj_filenames[i<<8]));
-            if (strstr(&filenames[i<<8], ".spin") == NULL)
-            {
-                strcat(&filenames[i<<8], ".spin");
-            }
+            ppObjNames[i] = InternSpinFilename(&(s_pCompilerData->obj_filenames[i<<8]));
         }
 
+        TraceBegin("children", "compile");
         for (int i = 0; i < numObjects; i++)
         {
-            if (!CompileRecursively(&filenames[i<<8], bQuiet, bFileTreeOutputOnly, nCompileIndex))
+            if (!CompileRecursively(ppObjNames[i]->text, bQuiet, bFileTreeOutputOnly, nCompileIndex))
             {
                 return false;
             }
         }
+        TraceEnd();
 
         if (!GetPASCIISource(pFilename))
         {
@@ -260,20 +380,27 @@ bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly,
             return false;
         }
 
-        strcpy(s_pCompilerData->current_filename, pFilename);
-        char* pExtension = strstr(s_pCompilerData->current_filename, ".spin");
-        if (pExtension != 0)
-        {
-            *pExtension = 0;
-        }
+        SetCurrentFilename(pName);
+        TraceBegin("pass 1", "compile");
         pErrorString = Compile1();
+        TraceEnd();
         if (pErrorString != 0)
         {
             PrintError(pFilename, pErrorString);
             return false;
         }
 
-        if (!CopyObjectsFromHeap(s_pCompilerData, filenames))
+        // CopyObjectsFromHeap() takes the names in 256 byte slots, each child checked that its name fits
+        ArenaMark mark = GetArenaMark();
+        char* pFilenames = (char*)ArenaAlloc(numObjects << 8);
+        for (int i = 0; i < numObjects; i++)
+        {
+            memcpy(&pFilenames[i<<8], ppObjNames[i]->text, ppObjNames[i]->length + 1);
+        }
+
+        bool bCopied = CopyObjectsFromHeap(s_pCompilerData, pFilenames);
+        ArenaRewind(mark);
+        if (!bCopied)
         {
             printf("%s : error : Object files exceed 128k.\n", pFilename);
             return false;
@@ -283,17 +410,22 @@ bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly,
     // load all DAT files
     if (s_pCompilerData->dat_files > 0)
     {
+        TraceBegin("DAT load", "io");
         int p = 0;
         for (int i = 0; i < s_pCompilerData->dat_files; i++)
         {
             // Get DAT's Files
+            char* pDatFilename = &(s_pCompilerData->dat_filenames[i<<8]);
 
-            // Get name information
-            char filename[256];
-            strcpy(&filename[0], &(s_pCompilerData->dat_filenames[i<<8]));
-
-            // Load file and add to dat_data buffer
-            s_pCompilerData->dat_lengths[i] = GetData(&(s_pCompilerData->dat_data[p]), &filename[0], data_limit - p);
+            // Load file and add to dat_data buffer, or only size it when no image will be written
+            if (s_bDataSizeOnly)
+            {
+                s_pCompilerData->dat_lengths[i] = GetDataSize(pDatFilename, data_limit - p);
+            }
+            else
+            {
+                s_pCompilerData->dat_lengths[i] = GetData(&(s_pCompilerData->dat_data[p]), pDatFilename, data_limit - p);
+            }
             if (s_pCompilerData->dat_lengths[i] == -1)
             {
                 s_pCompilerData->dat_lengths[i] = 0;
@@ -307,16 +439,14 @@ bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly,
             s_pCompilerData->dat_offsets[i] = p;
             p += s_pCompilerData->dat_lengths[i];
         }
+        TraceEnd();
     }
 
     // second pass of object
-    strcpy(s_pCompilerData->current_filename, pFilename);
-    pExtension = strstr(s_pCompilerData->current_filename, ".spin");
-    if (pExtension != 0)
-    {
-        *pExtension = 0;
-    }
+    SetCurrentFilename(pName);
+    TraceBegin("pass 2", "compile");
     pErrorString = Compile2();
+    TraceEnd();
     if (pErrorString != 0)
     {
         PrintError(pFilename, pErrorString);
@@ -331,13 +461,94 @@ bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly,
         return false;
     }
 
+    // the heap only keeps the code, the map needs the names while the source is still loaded
+    if (s_bRecordSymbols)
+    {
+        RecordObjectSymbols(pName);
+    }
+
     // save this object in the heap
+    TraceBegin("heap insert", "compile");
     if (!AddObjectToHeap(pFilename, s_pCompilerData))
     {
         printf("%s : error : Object Heap Overflow.\n", pFilename);
         return false;
     }
+    TraceEnd();
+    FinishObjectReport(nReportIndex, s_pCompilerData);
     s_nObjStackPtr--;
+    TraceEnd();
+
+    return true;
+}
+
+// Compiles a single object straight from memory, without touching the file system.
+// Objects it references can't be resolved, FILE payloads are treated as empty.
+// Used by the fuzz and stress harnesses, call CleanupMemory(false) after each one.
+bool CompileBuffer(const char* pBuffer, int nLength, const char* pName, unsigned int eeprom_size)
+{
+    s_pCompilerData = InitStruct();
+    s_pCompilerData->bUnusedMethodElimination = false;
+    s_pCompilerData->bFinalCompile = false;
+    // nothing reads the listing here, so it isn't cleared. The arena hands the same
+    // block back on every call, so the 2MB buffer costs neither a malloc nor a memset.
+    s_pCompilerData->list = (char*)ArenaAlloc(ListLimit);
+    s_pCompilerData->list[0] = 0;
+    s_pCompilerData->list_limit = ListLimit;
+    s_pCompilerData->doc = 0;
+    s_pCompilerData->doc_limit = 0;
+    s_pCompilerData->bBinary = true;
+    s_pCompilerData->eeprom_size = eeprom_size;
+    s_pCompilerData->obj_limit = eeprom_size > min_obj_limit ? eeprom_size : min_obj_limit;
+    s_pCompilerData->obj = (unsigned char*)ArenaAlloc(s_pCompilerData->obj_limit);
+
+    PooledName* pObjName = InternSpinFilename(pName);
+    if (pObjName->length >= 256)
+    {
+        printf("%s : error : Object filename exceeds %d characters.\n", pObjName->text, 255);
+        return false;
+    }
+    SetCurrentFilename(pObjName);
+    memcpy(s_pCompilerData->obj_title, pObjName->text, pObjName->baseLength);
+    s_pCompilerData->obj_title[pObjName->baseLength] = 0;
+
+    // same conversion GetPASCIISource() does for a file
+    ArenaMark mark = GetArenaMark();
+    char* pSource = (char*)ArenaAlloc(nLength+1);
+    memcpy(pSource, pBuffer, nLength);
+    pSource[nLength] = 0;
+    bool bConverted = SetPASCIISource(pSource, nLength);
+    ArenaRewind(mark);
+    if (!bConverted)
+    {
+        return false;
+    }
+
+    const char* pErrorString = Compile1();
+    if (pErrorString != 0)
+    {
+        PrintError(pObjName->text, pErrorString);
+        return false;
+    }
+
+    if (s_pCompilerData->obj_files > 0)
+    {
+        printf("%s : error : Objects can not be referenced from an in-memory compile.\n", pObjName->text);
+        return false;
+    }
+
+    for (int i = 0; i < s_pCompilerData->dat_files; i++)
+    {
+        s_pCompilerData->dat_lengths[i] = 0;
+        s_pCompilerData->dat_offsets[i] = 0;
+    }
+
+    pErrorString = Compile2();
+    if (pErrorString != 0)
+    {
+        PrintError(pObjName->text, pErrorString);
+        return false;
+    }
 
     return true;
 }
@@ -357,8 +568,7 @@ bool ComposeRAM(unsigned char** ppBuffer, int& bufferSize, bool bBinary, unsigne
     if (bBinary)
     {
        // reset ram
-       *ppBuffer = new unsigned char[vbase];
-       memset(*ppBuffer, 0, vbase);
+       *ppBuffer = (unsigned char*)ArenaAllocZeroed(vbase);
        bufferSize = vbase;
     }
     else
@@ -369,8 +579,7 @@ bool ComposeRAM(unsigned char** ppBuffer, int& bufferSize, bool bBinary, unsigne
           return false;
        }
        // reset ram
-       *ppBuffer = new unsigned char[eeprom_size];
-       memset(*ppBuffer, 0, eeprom_size);
+       *ppBuffer = (unsigned char*)ArenaAllocZeroed(eeprom_size);
        bufferSize = eeprom_size;
        (*ppBuffer)[dbase-8] = 0xFF;
        (*ppBuffer)[dbase-7] = 0xFF;
@@ -408,21 +617,40 @@ bool ComposeRAM(unsigned char** ppBuffer, int& bufferSize, bool bBinary, unsigne
 }
 
 
-void CleanupMemory(bool bPathsAndUnusedMethodData)
+// returns false if the trace could not be written
+bool CleanupMemory(bool bPathsAndUnusedMethodData)
 {
-    // cleanup
+    bool bResult = true;
+
+    // cleanup, list/doc/obj/source all come from the arena
     if ( s_pCompilerData )
     {
-        delete [] s_pCompilerData->list;
-        delete [] s_pCompilerData->doc;
-        delete [] s_pCompilerData->obj;
-        delete [] s_pCompilerData->source;
+        s_pCompilerData->list = NULL;
+        s_pCompilerData->doc = NULL;
+        s_pCompilerData->obj = NULL;
+        s_pCompilerData->source = NULL;
     }
+    ResetNamePool();
+    ResetSymbolMap();
+    ArenaReset(s_sourceArena);
+    ArenaReset();
+    ArenaResetPeak();
+    ResetObjectReport();
     CleanObjectHeap();
     if (bPathsAndUnusedMethodData)
     {
         CleanupPathEntries();
         CleanUpUnusedMethodData();
+        bResult = FinishTrace();
+
+        // this is the final cleanup, so the blocks kept for the next compile can go
+        ArenaTrim(s_sourceArena);
+        ArenaTrim();
     }
     Cleanup();
+
+    // Cleanup() releases the compiler data, repeated in-memory compiles must not see it again
+    s_pCompilerData = NULL;
+
+    return bResult;
 }
@@ -7,6 +7,8 @@
 #define ListLimit           2000000
 #define DocLimit            2000000
 
+#define HashSeed            2166136261u     // FNV-1a offset basis for HashBytes()
+
 #define MAX_FILES           2048    // an object can only reference 32 other objects and only 32 dat files, so the worst case is 32*32*2 files
 
 #ifndef OPENSPIN_H
@@ -17,19 +19,32 @@
 #include "pathentry.h"
 #include "textconvert.h"
 #include "preprocess.h"
+#include "arena.h"
+#include "objectreport.h"
+#include "imagedelta.h"
+#include "namepool.h"
+#include "symbolmap.h"
+#include "trace.h"
 
 #endif
 
 extern CompilerData* s_pCompilerData;
 extern char s_filesAccessed[MAX_FILES][PATH_MAX];
 extern bool s_bUnusedMethodElimination;
+extern bool s_bDataSizeOnly;
+extern bool s_bRecordSymbols;
 
 
 FILE* OpenFileInPath(const char *name, const char *mode);
 char* LoadFile(char* pFilename, int* pnLength);
 int GetData(unsigned char* pDest, char* pFileName, int nMaxSize);
+int GetDataSize(char* pFileName, int nMaxSize);
+unsigned int HashBytes(unsigned int hash, const void* pData, int nLength);
+void WriteLong(FILE* pFile, unsigned int value);
+void WriteJSONString(FILE* pFile, const char* pString);
 bool GetPASCIISource(char* pFilename);
 void PrintError(const char* pFilename, const char* pErrorString);
 bool CompileRecursively(char* pFilename, bool bQuiet, bool bFileTreeOutputOnly, int& nCompileIndex);
+bool CompileBuffer(const char* pBuffer, int nLength, const char* pName, unsigned int eeprom_size);
 bool ComposeRAM(unsigned char** ppBuffer, int& bufferSize, bool bBinary, unsigned int eeprom_size);
-void CleanupMemory(bool bPathsAndUnusedMethodData = true);
+bool CleanupMemory(bool bPathsAndUnusedMethodData = true);
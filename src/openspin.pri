@@ -0,0 +1,61 @@
+# compiler sources shared by the openspin tool and the fuzz harnesses
+
+INCLUDEPATH += \
+    $$PWD \
+    $$PWD/base/PropellerCompiler \
+    $$PWD/base/SpinSource \
+
+SOURCES += \
+    $$PWD/base/PropellerCompiler/BlockNestStackRoutines.cpp \
+    $$PWD/base/PropellerCompiler/CompileDatBlocks.cpp \
+    $$PWD/base/PropellerCompiler/CompileExpression.cpp \
+    $$PWD/base/PropellerCompiler/CompileInstruction.cpp \
+    $$PWD/base/PropellerCompiler/CompileUtilities.cpp \
+    $$PWD/base/PropellerCompiler/DistillObjects.cpp \
+    $$PWD/base/PropellerCompiler/Elementizer.cpp \
+    $$PWD/base/PropellerCompiler/ErrorStrings.cpp \
+    $$PWD/base/PropellerCompiler/ExpressionResolver.cpp \
+    $$PWD/base/PropellerCompiler/InstructionBlockCompiler.cpp \
+    $$PWD/base/PropellerCompiler/PropellerCompiler.cpp \
+    $$PWD/base/PropellerCompiler/StringConstantRoutines.cpp \
+    $$PWD/base/PropellerCompiler/SymbolEngine.cpp \
+	$$PWD/base/PropellerCompiler/UnusedMethodUtils.cpp \
+    $$PWD/base/PropellerCompiler/Utilities.cpp \
+    $$PWD/base/SpinSource/flexbuf.cpp \
+    $$PWD/base/SpinSource/objectheap.cpp \
+    $$PWD/base/SpinSource/pathentry.cpp \
+    $$PWD/base/SpinSource/preprocess.cpp \
+    $$PWD/base/SpinSource/textconvert.cpp
+
+HEADERS += \
+    $$PWD/base/PropellerCompiler/CompileUtilities.h \
+    $$PWD/base/PropellerCompiler/Elementizer.h \
+    $$PWD/base/PropellerCompiler/ErrorStrings.h \
+    $$PWD/base/PropellerCompiler/PropellerCompiler.h \
+    $$PWD/base/PropellerCompiler/PropellerCompilerInternal.h \
+    $$PWD/base/PropellerCompiler/SymbolEngine.h \
+    $$PWD/base/PropellerCompiler/Utilities.h \
+	$$PWD/base/PropellerCompiler/UnusedMethodUtils.h \
+    $$PWD/base/SpinSource/flexbuf.h \
+    $$PWD/base/SpinSource/objectheap.h \
+    $$PWD/base/SpinSource/pathentry.h \
+    $$PWD/base/SpinSource/preprocess.h \
+    $$PWD/base/SpinSource/textconvert.h
+
+SOURCES += \
+    $$PWD/arena.cpp \
+    $$PWD/imagedelta.cpp \
+    $$PWD/namepool.cpp \
+    $$PWD/objectreport.cpp \
+    $$PWD/openspin.cpp \
+    $$PWD/symbolmap.cpp \
+    $$PWD/trace.cpp
+
+HEADERS += \
+    $$PWD/arena.h \
+    $$PWD/imagedelta.h \
+    $$PWD/namepool.h \
+    $$PWD/objectreport.h \
+    $$PWD/openspin.h \
+    $$PWD/symbolmap.h \
+    $$PWD/trace.h
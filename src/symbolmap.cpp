@@ -0,0 +1,467 @@
+//
+// symbolmap.cpp
+//
+//
+#include "openspin.h"
+
+#define MapImageBase        0x0010  // ComposeRAM() places the top object here
+#define MapObjectLimit      1024
+
+struct MapSymbol
+{
+    unsigned int address;
+    unsigned int size;
+    unsigned int name;
+    unsigned int kind;
+};
+
+struct MapLine
+{
+    unsigned int address;
+    unsigned int line;
+    unsigned int file;
+};
+
+struct MapMethodRecord
+{
+    const char*  pName;
+    int          nStart;        // name range in the source, only used while recording
+    int          nLength;
+    unsigned int line;
+    unsigned int kind;
+};
+
+struct MapDatRecord
+{
+    unsigned int offset;        // from the start of the object
+    unsigned int line;
+};
+
+struct MapObjectRecord
+{
+    MapObjectRecord*  pNext;
+    const PooledName* pName;
+    unsigned int      fingerprint;
+    unsigned int      length;
+    int               nMethods;
+    MapMethodRecord*  pMethods;     // in method table order
+    int               nDats;
+    MapDatRecord*     pDats;
+};
+
+// one record per distinct object of the compile, kept in the compile arena
+static MapObjectRecord* s_pObjectRecords = NULL;
+
+// all of the tables are built in the compile arena, so they go away with the rest of the compile
+static MapSymbol* s_pMapSymbols = NULL;
+static int s_nMapSymbols = 0;
+static int s_nMapSymbolLimit = 0;
+static MapLine* s_pMapLines = NULL;
+static int s_nMapLines = 0;
+static int s_nMapLineLimit = 0;
+static char* s_pMapStrings = NULL;
+static int s_nMapStringsSize = 0;
+static int s_nMapStringsLimit = 0;
+static int* s_pLineStarts = NULL;
+static int s_nLineCount = 0;
+static unsigned int s_visitedObjects[MapObjectLimit];
+static int s_nVisitedObjects = 0;
+
+static void* GrowTable(void* pTable, int nCount, int& nLimit, int nElementSize)
+{
+    if (nCount < nLimit)
+    {
+        return pTable;
+    }
+    nLimit = nLimit > 0 ? nLimit << 1 : 256;
+    void* pNewTable = ArenaAlloc(nLimit * nElementSize);
+    if (pTable)
+    {
+        memcpy(pNewTable, pTable, nCount * nElementSize);
+    }
+    return pNewTable;
+}
+
+static unsigned int AddMapString(const char* pString, int nLength)
+{
+    while (s_nMapStringsSize + nLength + 1 > s_nMapStringsLimit)
+    {
+        s_pMapStrings = (char*)GrowTable(s_pMapStrings, s_nMapStringsLimit, s_nMapStringsLimit, 1);
+    }
+    unsigned int nOffset = s_nMapStringsSize;
+    memcpy(&s_pMapStrings[s_nMapStringsSize], pString, nLength);
+    s_pMapStrings[s_nMapStringsSize + nLength] = 0;
+    s_nMapStringsSize += nLength + 1;
+    return nOffset;
+}
+
+static void AddMapSymbol(unsigned int address, unsigned int name, unsigned int kind)
+{
+    s_pMapSymbols = (MapSymbol*)GrowTable(s_pMapSymbols, s_nMapSymbols, s_nMapSymbolLimit, sizeof(MapSymbol));
+    MapSymbol& symbol = s_pMapSymbols[s_nMapSymbols++];
+    symbol.address = address;
+    symbol.size = 0;
+    symbol.name = name;
+    symbol.kind = kind;
+}
+
+static void AddMapLine(unsigned int address, unsigned int line, unsigned int file)
+{
+    s_pMapLines = (MapLine*)GrowTable(s_pMapLines, s_nMapLines, s_nMapLineLimit, sizeof(MapLine));
+    MapLine& entry = s_pMapLines[s_nMapLines++];
+    entry.address = address;
+    entry.line = line;
+    entry.file = file;
+}
+
+// record where every source line starts once, so each lookup is a binary search
+static void BuildLineStarts()
+{
+    const char* pSource = s_pCompilerData->source;
+    int nLength = (int)strlen(pSource);
+    int nLimit = 0;
+
+    s_pLineStarts = NULL;
+    s_nLineCount = 0;
+    s_pLineStarts = (int*)GrowTable(s_pLineStarts, s_nLineCount, nLimit, sizeof(int));
+    s_pLineStarts[s_nLineCount++] = 0;
+    for (int i = 0; i < nLength; i++)
+    {
+        if (pSource[i] == 13 || pSource[i] == 10)
+        {
+            if (pSource[i] == 13 && pSource[i+1] == 10)
+            {
+                i++;
+            }
+            s_pLineStarts = (int*)GrowTable(s_pLineStarts, s_nLineCount, nLimit, sizeof(int));
+            s_pLineStarts[s_nLineCount++] = i + 1;
+        }
+    }
+}
+
+static unsigned int LineFromOffset(int nOffset)
+{
+    int nLow = 0;
+    int nHigh = s_nLineCount - 1;
+    while (nLow < nHigh)
+    {
+        int nMid = (nLow + nHigh + 1) >> 1;
+        if (s_pLineStarts[nMid] <= nOffset)
+        {
+            nLow = nMid;
+        }
+        else
+        {
+            nHigh = nMid - 1;
+        }
+    }
+    return nLow + 1;
+}
+
+static int ReadWord(const unsigned char* pImage, unsigned int nOffset)
+{
+    return pImage[nOffset] | (pImage[nOffset+1] << 8);
+}
+
+// identifies an object by its own code and data. The object table entries are left out,
+// they are rewritten when the parent places its children, everything else is position independent.
+static bool ObjectFingerprint(const unsigned char* pObject, unsigned int nAvailable, unsigned int& length, unsigned int& fingerprint)
+{
+    if (nAvailable < 4)
+    {
+        return false;
+    }
+    length = ReadWord(pObject, 0);
+    unsigned int nMethodTableEnd = pObject[2] << 2;
+    unsigned int nTablesEnd = nMethodTableEnd + (pObject[3] << 2);
+    if (length < nTablesEnd || length > nAvailable)
+    {
+        return false;
+    }
+    fingerprint = HashBytes(HashSeed, pObject, nMethodTableEnd);
+    fingerprint = HashBytes(fingerprint, &pObject[nTablesEnd], length - nTablesEnd);
+    return true;
+}
+
+// saved after each object's second pass, so the map can name the methods of child objects too
+void RecordObjectSymbols(const PooledName* pName)
+{
+    for (MapObjectRecord* pRecord = s_pObjectRecords; pRecord; pRecord = pRecord->pNext)
+    {
+        if (pRecord->pName == pName)
+        {
+            return;
+        }
+    }
+
+    MapObjectRecord record;
+    if (!ObjectFingerprint(&(s_pCompilerData->obj[4]), s_pCompilerData->psize, record.length, record.fingerprint))
+    {
+        return;
+    }
+    record.pName = pName;
+    record.nMethods = 0;
+    record.nDats = 0;
+    for (int i = 0; i < s_pCompilerData->info_count; i++)
+    {
+        int type = s_pCompilerData->info_type[i];
+        if (type == info_pub || type == info_pri)
+        {
+            record.nMethods++;
+        }
+        else if (type == info_dat)
+        {
+            record.nDats++;
+        }
+    }
+    record.pMethods = (MapMethodRecord*)ArenaAlloc((record.nMethods + 1) * sizeof(MapMethodRecord));
+    record.pDats = (MapDatRecord*)ArenaAlloc((record.nDats + 1) * sizeof(MapDatRecord));
+
+    // only the line numbers are kept, the line starts go as soon as they have been looked up
+    ArenaMark mark = GetArenaMark();
+    BuildLineStarts();
+
+    // methods are numbered PUBs first, then PRIs, both in source order
+    int nMethod = 0;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int i = 0; i < s_pCompilerData->info_count; i++)
+        {
+            if (s_pCompilerData->info_type[i] != (pass == 0 ? info_pub : info_pri))
+            {
+                continue;
+            }
+            MapMethodRecord& method = record.pMethods[nMethod++];
+            method.nStart = s_pCompilerData->info_data2[i];
+            method.nLength = s_pCompilerData->info_data3[i] - method.nStart;
+            if (method.nLength < 0)
+            {
+                method.nLength = 0;
+            }
+            method.line = LineFromOffset(method.nStart);
+            method.kind = pass == 0 ? map_pub : map_pri;
+        }
+    }
+
+    // info_dat entries carry their obj range in data0/data1
+    int nDat = 0;
+    for (int i = 0; i < s_pCompilerData->info_count; i++)
+    {
+        if (s_pCompilerData->info_type[i] == info_dat)
+        {
+            record.pDats[nDat].offset = s_pCompilerData->info_data0[i];
+            record.pDats[nDat].line = LineFromOffset(s_pCompilerData->info_start[i]);
+            nDat++;
+        }
+    }
+    ArenaRewind(mark);
+
+    // the names are copied out of the source after the rewind, so they stay with the record
+    for (int i = 0; i < record.nMethods; i++)
+    {
+        MapMethodRecord& method = record.pMethods[i];
+        char* pMethodName = (char*)ArenaAlloc(method.nLength + 1);
+        memcpy(pMethodName, &s_pCompilerData->source[method.nStart], method.nLength);
+        pMethodName[method.nLength] = 0;
+        method.pName = pMethodName;
+    }
+
+    MapObjectRecord* pRecord = (MapObjectRecord*)ArenaAlloc(sizeof(MapObjectRecord));
+    *pRecord = record;
+    pRecord->pNext = s_pObjectRecords;
+    s_pObjectRecords = pRecord;
+}
+
+static MapObjectRecord* FindObjectRecord(const unsigned char* pObject, unsigned int nAvailable)
+{
+    unsigned int length = 0;
+    unsigned int fingerprint = 0;
+    if (!ObjectFingerprint(pObject, nAvailable, length, fingerprint))
+    {
+        return NULL;
+    }
+    for (MapObjectRecord* pRecord = s_pObjectRecords; pRecord; pRecord = pRecord->pNext)
+    {
+        if (pRecord->fingerprint == fingerprint && pRecord->length == length)
+        {
+            return pRecord;
+        }
+    }
+    return NULL;
+}
+
+// adds "object.name" for child objects, the top object's symbols keep their plain names
+static unsigned int AddQualifiedName(const MapObjectRecord* pRecord, bool bTop, const char* pName, int nLength)
+{
+    if (bTop)
+    {
+        return AddMapString(pName, nLength);
+    }
+    int nObjectLength = pRecord->pName->baseLength;
+    ArenaMark mark = GetArenaMark();
+    char* pQualified = (char*)ArenaAlloc(nObjectLength + 1 + nLength);
+    memcpy(pQualified, pRecord->pName->text, nObjectLength);
+    pQualified[nObjectLength] = '.';
+    memcpy(&pQualified[nObjectLength + 1], pName, nLength);
+    unsigned int name = AddMapString(pQualified, nObjectLength + 1 + nLength);
+    ArenaRewind(mark);
+    return name;
+}
+
+// walks the method and object tables of the object at nBase (offset into the image)
+static void MapObject(const unsigned char* pImage, unsigned int nImageSize, unsigned int nBase)
+{
+    if (nBase + 4 > nImageSize)
+    {
+        return;
+    }
+    for (int i = 0; i < s_nVisitedObjects; i++)
+    {
+        if (s_visitedObjects[i] == nBase)
+        {
+            return;
+        }
+    }
+    if (s_nVisitedObjects >= MapObjectLimit)
+    {
+        return;
+    }
+    s_visitedObjects[s_nVisitedObjects++] = nBase;
+
+    bool bTop = nBase == 0;
+    MapObjectRecord* pRecord = FindObjectRecord(&pImage[nBase], nImageSize - nBase);
+    unsigned int file = 0;
+    if (pRecord)
+    {
+        file = AddMapString(pRecord->pName->text, pRecord->pName->length);
+    }
+
+    int nMethodIndexEnd = pImage[nBase + 2];  // method count + 1
+    int nObjects = pImage[nBase + 3];
+
+    for (int i = 1; i < nMethodIndexEnd; i++)
+    {
+        if (nBase + (i << 2) + 2 > nImageSize)
+        {
+            return;
+        }
+        unsigned int address = MapImageBase + nBase + ReadWord(pImage, nBase + (i << 2));
+
+        if (pRecord && i - 1 < pRecord->nMethods)
+        {
+            const MapMethodRecord& method = pRecord->pMethods[i - 1];
+            AddMapSymbol(address, AddQualifiedName(pRecord, bTop, method.pName, method.nLength), method.kind);
+            AddMapLine(address, method.line, file);
+        }
+        else
+        {
+            char szName[32];
+            sprintf(szName, "object_%04X.method_%d", MapImageBase + nBase, i);
+            AddMapSymbol(address, AddMapString(szName, (int)strlen(szName)), map_method);
+        }
+    }
+
+    if (pRecord)
+    {
+        for (int i = 0; i < pRecord->nDats; i++)
+        {
+            unsigned int address = MapImageBase + nBase + pRecord->pDats[i].offset;
+            AddMapSymbol(address, AddQualifiedName(pRecord, bTop, "DAT", 3), map_dat);
+            AddMapLine(address, pRecord->pDats[i].line, file);
+        }
+    }
+
+    for (int i = 0; i < nObjects; i++)
+    {
+        unsigned int nEntry = nBase + ((nMethodIndexEnd + i) << 2);
+        if (nEntry + 2 > nImageSize)
+        {
+            return;
+        }
+        MapObject(pImage, nImageSize, nBase + ReadWord(pImage, nEntry));
+    }
+}
+
+static int CompareAddress(const void* pA, const void* pB)
+{
+    unsigned int a = *(const unsigned int*)pA;
+    unsigned int b = *(const unsigned int*)pB;
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+bool WriteSymbolMap(const char* pFilename)
+{
+    s_pMapSymbols = NULL;
+    s_nMapSymbols = s_nMapSymbolLimit = 0;
+    s_pMapLines = NULL;
+    s_nMapLines = s_nMapLineLimit = 0;
+    s_pMapStrings = NULL;
+    s_nMapStringsSize = s_nMapStringsLimit = 0;
+    s_nVisitedObjects = 0;
+
+    const unsigned char* pImage = &(s_pCompilerData->obj[4]);
+    unsigned int nImageSize = s_pCompilerData->psize;
+    MapObject(pImage, nImageSize, 0);
+
+    // address is the first field of both records, so one comparison sorts either table
+    if (s_nMapSymbols > 0)
+    {
+        qsort(s_pMapSymbols, s_nMapSymbols, sizeof(MapSymbol), CompareAddress);
+    }
+    if (s_nMapLines > 0)
+    {
+        qsort(s_pMapLines, s_nMapLines, sizeof(MapLine), CompareAddress);
+    }
+
+    // each symbol runs up to the next one, the last one to the end of the code
+    for (int i = 0; i < s_nMapSymbols; i++)
+    {
+        unsigned int end = (i + 1 < s_nMapSymbols) ? s_pMapSymbols[i+1].address : MapImageBase + nImageSize;
+        s_pMapSymbols[i].size = end > s_pMapSymbols[i].address ? end - s_pMapSymbols[i].address : 0;
+    }
+
+    FILE* pFile = fopen(pFilename, "wb");
+    if (!pFile)
+    {
+        printf("Cannot open map file: %s\n", pFilename);
+        return false;
+    }
+
+    unsigned int nHeaderSize = 8 * 4;
+    unsigned int nSymbolsOffset = nHeaderSize;
+    unsigned int nLinesOffset = nSymbolsOffset + s_nMapSymbols * 16;
+    unsigned int nStringsOffset = nLinesOffset + s_nMapLines * 12;
+
+    fwrite("OSMP", 1, 4, pFile);
+    WriteLong(pFile, SymbolMapVersion);
+    WriteLong(pFile, s_nMapSymbols);
+    WriteLong(pFile, s_nMapLines);
+    WriteLong(pFile, s_nMapStringsSize);
+    WriteLong(pFile, nSymbolsOffset);
+    WriteLong(pFile, nLinesOffset);
+    WriteLong(pFile, nStringsOffset);
+
+    for (int i = 0; i < s_nMapSymbols; i++)
+    {
+        WriteLong(pFile, s_pMapSymbols[i].address);
+        WriteLong(pFile, s_pMapSymbols[i].size);
+        WriteLong(pFile, s_pMapSymbols[i].name);
+        WriteLong(pFile, s_pMapSymbols[i].kind);
+    }
+    for (int i = 0; i < s_nMapLines; i++)
+    {
+        WriteLong(pFile, s_pMapLines[i].address);
+        WriteLong(pFile, s_pMapLines[i].line);
+        WriteLong(pFile, s_pMapLines[i].file);
+    }
+    fwrite(s_pMapStrings, 1, s_nMapStringsSize, pFile);
+    fclose(pFile);
+
+    return true;
+}
+
+// the records live in the arena, so this has to go along with ArenaReset()
+void ResetSymbolMap()
+{
+    s_pObjectRecords = NULL;
+}
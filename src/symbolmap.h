@@ -0,0 +1,43 @@
+//
+// symbolmap.h
+//
+// Writes a compact, indexed symbol and line map next to the output image.
+// All fields are little endian 32-bit values:
+//
+//   header   magic 'OSMP', version, symbol count, line count, string table size,
+//            symbol table offset, line table offset, string table offset
+//   symbols  address, size, name (string table offset), kind     sorted by address
+//   lines    address, line, file (string table offset)           sorted by address
+//   strings  NUL terminated names
+//
+// Addresses are hub addresses in the composed image. CompileRecursively() records
+// each object's PUB/PRI names, lines and DAT blocks with RecordObjectSymbols(), and
+// the map writer matches them to the objects it finds in the image by their code.
+// Symbols of child objects are named "object.method", the top object's are not;
+// line entries refer to the object's file.
+//
+// The line table is per method and DAT block, not per statement: each entry gives
+// the line a PUB, PRI or DAT block starts on, so an address maps to the line of the
+// block that contains it. The map relies on methods keeping their source order in
+// the method table, so it is not available together with -u.
+//
+#ifndef SYMBOLMAP_H
+#define SYMBOLMAP_H
+
+#define SymbolMapVersion    1
+
+enum
+{
+    map_pub = 0,
+    map_pri,
+    map_dat,
+    map_method,         // method of a child object, named by object address and index
+};
+
+struct PooledName;
+
+void RecordObjectSymbols(const PooledName* pName);
+bool WriteSymbolMap(const char* pFilename);
+void ResetSymbolMap();
+
+#endif
@@ -0,0 +1,146 @@
+//
+// trace.cpp
+//
+//
+#include <chrono>
+
+#include "openspin.h"
+
+struct TraceEvent
+{
+    long long   timestamp;  // microseconds since StartTrace()
+    int         name;       // offset into the trace string buffer
+    const char* pCategory;
+    char        phase;      // 'B' or 'E'
+};
+
+bool s_bTraceEnabled = false;
+
+// the trace spans both passes of unused method removal, so it keeps its own
+// storage instead of using the compile arena
+static char* s_pTraceFilename = NULL;
+static TraceEvent* s_pTraceEvents = NULL;
+static int s_nTraceEvents = 0;
+static int s_nTraceEventLimit = 0;
+static char* s_pTraceStrings = NULL;
+static int s_nTraceStringsSize = 0;
+static int s_nTraceStringsLimit = 0;
+static int s_openEvents[TraceOpenLimit];
+static int s_nOpenEvents = 0;
+static std::chrono::steady_clock::time_point s_traceStart;
+
+static long long TraceTimestamp()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - s_traceStart).count();
+}
+
+static TraceEvent* AddTraceEvent()
+{
+    if (s_nTraceEvents >= s_nTraceEventLimit)
+    {
+        s_nTraceEventLimit = s_nTraceEventLimit > 0 ? s_nTraceEventLimit << 1 : 1024;
+        s_pTraceEvents = (TraceEvent*)realloc(s_pTraceEvents, s_nTraceEventLimit * sizeof(TraceEvent));
+    }
+    return &s_pTraceEvents[s_nTraceEvents++];
+}
+
+static int AddTraceString(const char* pString)
+{
+    int nLength = (int)strlen(pString);
+    while (s_nTraceStringsSize + nLength + 1 > s_nTraceStringsLimit)
+    {
+        s_nTraceStringsLimit = s_nTraceStringsLimit > 0 ? s_nTraceStringsLimit << 1 : 4096;
+        s_pTraceStrings = (char*)realloc(s_pTraceStrings, s_nTraceStringsLimit);
+    }
+    int nOffset = s_nTraceStringsSize;
+    memcpy(&s_pTraceStrings[nOffset], pString, nLength + 1);
+    s_nTraceStringsSize += nLength + 1;
+    return nOffset;
+}
+
+void TraceBeginEvent(const char* pName, const char* pCategory)
+{
+    TraceEvent* pEvent = AddTraceEvent();
+    pEvent->timestamp = TraceTimestamp();
+    pEvent->name = AddTraceString(pName);
+    pEvent->pCategory = pCategory;
+    pEvent->phase = 'B';
+
+    if (s_nOpenEvents < TraceOpenLimit)
+    {
+        s_openEvents[s_nOpenEvents] = s_nTraceEvents - 1;
+    }
+    s_nOpenEvents++;
+}
+
+void TraceEndEvent()
+{
+    if (s_nOpenEvents == 0)
+    {
+        return;
+    }
+    s_nOpenEvents--;
+
+    // the end event repeats the name and category so the file also reads well on its own
+    int nBegin = s_nOpenEvents < TraceOpenLimit ? s_openEvents[s_nOpenEvents] : -1;
+    TraceEvent* pEvent = AddTraceEvent();
+    pEvent->timestamp = TraceTimestamp();
+    pEvent->name = nBegin >= 0 ? s_pTraceEvents[nBegin].name : AddTraceString("");
+    pEvent->pCategory = nBegin >= 0 ? s_pTraceEvents[nBegin].pCategory : "";
+    pEvent->phase = 'E';
+}
+
+void StartTrace(const char* pFilename)
+{
+    s_pTraceFilename = new char[strlen(pFilename) + 1];
+    strcpy(s_pTraceFilename, pFilename);
+    s_traceStart = std::chrono::steady_clock::now();
+    s_bTraceEnabled = true;
+}
+
+// writes the trace and releases it, events left open by an error are closed first
+bool FinishTrace()
+{
+    if (!s_bTraceEnabled)
+    {
+        return true;
+    }
+
+    while (s_nOpenEvents > 0)
+    {
+        TraceEndEvent();
+    }
+    s_bTraceEnabled = false;
+
+    bool bResult = true;
+    FILE* pFile = fopen(s_pTraceFilename, "w");
+    if (pFile)
+    {
+        fprintf(pFile, "{\"traceEvents\":[");
+        for (int i = 0; i < s_nTraceEvents; i++)
+        {
+            const TraceEvent& event = s_pTraceEvents[i];
+            fprintf(pFile, "%s\n{\"name\":", i > 0 ? "," : "");
+            WriteJSONString(pFile, &s_pTraceStrings[event.name]);
+            fprintf(pFile, ",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":1,\"tid\":1}", event.pCategory, event.phase, event.timestamp);
+        }
+        fprintf(pFile, "\n],\"displayTimeUnit\":\"ms\"}\n");
+        fclose(pFile);
+    }
+    else
+    {
+        printf("Cannot open trace file: %s\n", s_pTraceFilename);
+        bResult = false;
+    }
+
+    free(s_pTraceEvents);
+    free(s_pTraceStrings);
+    delete [] s_pTraceFilename;
+    s_pTraceEvents = NULL;
+    s_pTraceStrings = NULL;
+    s_pTraceFilename = NULL;
+    s_nTraceEvents = s_nTraceEventLimit = 0;
+    s_nTraceStringsSize = s_nTraceStringsLimit = 0;
+
+    return bResult;
+}
@@ -0,0 +1,23 @@
+//
+// trace.h
+//
+// Build timeline in Chrome trace-event format (load the file in chrome://tracing
+// or Perfetto). Events are only recorded after StartTrace(), every TraceBegin/
+// TraceEnd is a single flag test otherwise.
+//
+#ifndef TRACE_H
+#define TRACE_H
+
+#define TraceOpenLimit      256
+
+extern bool s_bTraceEnabled;
+
+void TraceBeginEvent(const char* pName, const char* pCategory);
+void TraceEndEvent();
+void StartTrace(const char* pFilename);
+bool FinishTrace();
+
+#define TraceBegin(name, category)  do { if (s_bTraceEnabled) TraceBeginEvent(name, category); } while (0)
+#define TraceEnd()                  do { if (s_bTraceEnabled) TraceEndEvent(); } while (0)
+
+#endif
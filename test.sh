@@ -1,29 +1,213 @@
 #!/bin/bash
+#
+# Compiles every top-level program under test/ in parallel and compares
+# each image byte for byte against its golden copy in test/golden/. A program
+# without a golden image fails the run. Each image is also rebuilt with --delta
+# against a damaged copy of itself, and the delta must turn that copy back into
+# the new image.
+#
+#   ./test.sh           run the regression suite
+#   ./test.sh bless     (re)generate the golden images from the current build
+#   ./test.sh clean     remove generated images
+#
+# SPINC selects the compiler, JOBS the number of parallel compiles.
 
 if [ -z "$SPINC" ]
 then
     SPINC="./bin/openspin"
 fi
 
+if [ -z "$JOBS" ]
+then
+    JOBS=`nproc 2>/dev/null || echo 4`
+fi
+
+GOLDEN="test/golden"
+OUTPUT="test/output"
+
 if [ "$1" == "clean" ]
 then
-    find test/ -name \*.binary -exec rm {} \;
+    find test/ -path "$GOLDEN" -prune -o -name \*.binary -exec rm {} \;
+    rm -rf "$OUTPUT"
     exit
 fi
 
+MODE="test"
+if [ "$1" == "bless" ]
+then
+    MODE="bless"
+fi
+
+# library objects are only compiled as children, so only programs that no
+# other object in the corpus references through an OBJ declaration are built
+find_programs()
+{
+    local referenced=`grep -rhoE '^[[:space:]]*[A-Za-z_][A-Za-z0-9_]*(\[[^]]*\])?[[:space:]]*:[[:space:]]*"[^"]+"' \
+        --include=\*.spin test/ | sed -E 's/.*"([^"]+)".*/\1/; s/\.spin$//' | sort -u`
+
+    find test/ -name \*.spin | sort | while read file
+    do
+        name=`basename "$file" .spin`
+        if ! echo "$referenced" | grep -qxF "$name"
+        then
+            echo "$file"
+        fi
+    done
+}
+
+# applies an OSDL delta written by --delta to a previous image
+apply_delta()
+{
+    local previous="$1"
+    local delta="$2"
+    local result="$3"
+
+    if [ ! -f "$delta" ] || [ "`head -c 4 "$delta"`" != "OSDL" ]
+    then
+        return 1
+    fi
+
+    local header=(`od -An -tu4 --endian=little -j 4 -N 16 "$delta"`)
+    local size=${header[2]}
+    local ranges=${header[3]}
+
+    cp "$previous" "$result"
+    truncate -s "$size" "$result"
+
+    local pos=20
+    for (( i = 0; i < ranges; i++ ))
+    do
+        local range=(`od -An -tu4 --endian=little -j $pos -N 8 "$delta"`)
+        dd if="$delta" of="$result" bs=1 skip=$(( pos + 8 )) seek=${range[0]} count=${range[1]} \
+            conv=notrunc status=none || return 1
+        pos=$(( pos + 8 + range[1] ))
+    done
+}
+
+# flips the byte at the given offset in place
+flip_byte()
+{
+    local file="$1"
+    local offset="$2"
+    local value=`od -An -tu1 -j "$offset" -N 1 "$file"`
+
+    printf "\\$(printf %03o $(( ~value & 255 )))" | dd of="$file" bs=1 seek="$offset" conv=notrunc status=none
+}
+
+# builds the EEPROM image of a program against a damaged copy of its .binary and
+# checks that applying the resulting delta to that copy reproduces the new image,
+# the previous image is shorter so the ranges past the code are exercised as well
+check_delta()
+{
+    local file="$1"
+    local out="$2"
+    local base="${out%.binary}"
+    local size=`stat -c %s "$out"`
+
+    cp "$out" "$base.prev"
+    flip_byte "$base.prev" 16
+    flip_byte "$base.prev" $(( size / 2 ))
+    flip_byte "$base.prev" $(( size - 1 ))
+
+    ${SPINC} -L . -q -e --delta "$base.prev" -o "$base.next.eeprom" "$file" >>"$base.log" 2>&1 &&
+        apply_delta "$base.prev" "$base.next.delta" "$base.applied" &&
+        cmp -s "$base.applied" "$base.next.eeprom"
+}
+
+# prints "<status> <delta status> <milliseconds> <file>" for one program, the
+# delta check runs after the golden comparison and doesn't change its status
+run_one()
+{
+    local file="$1"
+    local rel="${file#test/}"
+    local out="$OUTPUT/${rel%.spin}.binary"
+    local golden="$GOLDEN/${rel%.spin}.binary"
+    local log="$OUTPUT/${rel%.spin}.log"
+
+    mkdir -p "`dirname "$out"`"
+
+    local start=`date +%s%N`
+    ${SPINC} -L . -q -o "$out" "$file" >"$log" 2>&1
+    local result=$?
+    local end=`date +%s%N`
+    local ms=$(( (end - start) / 1000000 ))
+
+    local status
+    if [ $result != 0 ]
+    then
+        status="ERROR"
+    elif [ "$MODE" == "bless" ]
+    then
+        mkdir -p "`dirname "$golden"`"
+        cp "$out" "$golden"
+        status="BLESS"
+    elif [ ! -f "$golden" ]
+    then
+        status="NOGOLD"
+    elif cmp -s "$out" "$golden"
+    then
+        status="PASS"
+    else
+        status="DIFF"
+    fi
+
+    # only programs that compile get the extra delta build, and blessing skips it
+    local delta="-"
+    if [ $result == 0 ] && [ "$MODE" == "test" ]
+    then
+        if check_delta "$file" "$out"
+        then
+            delta="OK"
+        else
+            delta="FAIL"
+        fi
+    fi
+
+    echo "$status $delta $ms $file"
+}
+
+export -f run_one check_delta apply_delta flip_byte
+export SPINC MODE GOLDEN OUTPUT
+
 rm -f spin.log
+mkdir -p "$OUTPUT"
+
+START=`date +%s%N`
+find_programs | xargs -P "$JOBS" -I{} bash -c 'run_one "$@"' _ {} > "$OUTPUT/results.txt"
+END=`date +%s%N`
 
-while read line
+sort -k4 "$OUTPUT/results.txt" | while read status delta ms file
 do
-    echo "${SPINC} -L . $line"
-    ${SPINC} -L . "$line" >/dev/null
-    if [ $? != 0 ]
-    then 
-        echo "${SPINC} -L . $line" >> spin.log
-        ${SPINC} -L . "$line"
+    printf "%-6s delta %-4s %6d ms  %s\n" "$status" "$delta" "$ms" "$file"
+    base="${file#test/}"
+    base="${base%.spin}"
+    case "$status" in
+        ERROR)
+            echo "${SPINC} -L . $file" >> spin.log
+            cat "$OUTPUT/$base.log"
+            ;;
+        NOGOLD)
+            echo "$file has no golden image $GOLDEN/$base.binary" >> spin.log
+            ;;
+        DIFF)
+            echo "$file differs from $GOLDEN/$base.binary" >> spin.log
+            cmp -l "$OUTPUT/$base.binary" "$GOLDEN/$base.binary" 2>&1 | head -5
+            ;;
+    esac
+    if [ "$delta" == "FAIL" ]
+    then
+        echo "$file delta does not reproduce $OUTPUT/$base.next.eeprom" >> spin.log
     fi
-done < <(find . -name \*.spin)
+done
 
+TOTAL=`cat "$OUTPUT/results.txt" | wc -l`
+NOGOLD=`grep -c '^NOGOLD' "$OUTPUT/results.txt"`
+echo
+echo "$TOTAL programs in $(( (END - START) / 1000000 )) ms with $JOBS jobs."
+if [ "$NOGOLD" != 0 ]
+then
+    echo "$NOGOLD programs have no golden image, run ./test.sh bless with a known good compiler and check in $GOLDEN."
+fi
 
 if [ -f spin.log ] ; then
     ERRORS=`cat spin.log | wc -l`